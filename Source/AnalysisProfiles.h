@@ -0,0 +1,41 @@
+/*
+  ==============================================================================
+
+    AnalysisProfiles.h
+    Created: 20 Oct 2026 9:12:40am
+    Author:  arago
+
+    Compile time settings for the analysis pipeline. Each profile is used as
+    the template argument of ProfileFingerprinter (see Fingerprinter.h), so
+    its FFT size, row count and peak count are constants in the hot loops.
+    A database only matches queries made with the profile it was built with,
+    HashTable records the profile's name and refuses databases that don't.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+// the original FFT size, rows and peaks, used when --build isn't given a profile
+struct DefaultProfile {
+    static constexpr const char* name = "default";
+    static constexpr int fftOrder = 13;
+    static constexpr int frequencyRows = 330; // same as the spectrogram height
+    static constexpr int peaksPerFrame = 5;
+};
+
+// short frames for live input, a frame every ~46ms at 44.1kHz with fewer rows and peaks to hash
+struct LiveProfile {
+    static constexpr const char* name = "live";
+    static constexpr int fftOrder = 11;
+    static constexpr int frequencyRows = 128;
+    static constexpr int peaksPerFrame = 3;
+};
+
+// long frames with more rows and peaks, slower but tells similar recordings apart better
+struct ArchivalProfile {
+    static constexpr const char* name = "archival";
+    static constexpr int fftOrder = 14;
+    static constexpr int frequencyRows = 512;
+    static constexpr int peaksPerFrame = 8;
+};
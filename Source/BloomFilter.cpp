@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+
+    BloomFilter.cpp
+    Created: 19 Oct 2026 10:02:14am
+    Author:  arago
+
+  ==============================================================================
+*/
+
+#include "BloomFilter.h"
+
+BloomFilter::BloomFilter(size_t expectedKeys) {
+    reset(expectedKeys);
+}// end BloomFilter()
+
+void BloomFilter::reset(size_t expectedKeys) {
+    if (expectedKeys == 0) {
+        expectedKeys = 1;
+    }
+    size_t numBlocks = (expectedKeys * bitsPerKey + 511) / 512;
+    blocks.assign(numBlocks, Block{});
+    numKeys = 0;
+    maxKeys = expectedKeys;
+}// end reset()
+
+uint64_t BloomFilter::mix(uint64_t key) {
+    // splitmix64 finalizer, spreads the fingerprint sums across all 64 bits
+    key += 0x9e3779b97f4a7c15ULL;
+    key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+    return key ^ (key >> 31);
+}// end mix()
+
+void BloomFilter::insert(long key) {
+    uint64_t h = mix((uint64_t)key);
+    Block& block = blocks[(size_t)(h % blocks.size())];
+    // a second mix gives 9 independent bits per probe to pick one of the 512 bits in the block
+    uint64_t probes = mix(h);
+    for (int i = 0; i < hashesPerKey; i++) {
+        int bit = (int)((probes >> (i * 9)) & 511);
+        block[bit >> 6] |= (uint64_t)1 << (bit & 63);
+    }
+    numKeys++;
+}// end insert()
+
+bool BloomFilter::mightContain(long key) const {
+    uint64_t h = mix((uint64_t)key);
+    const Block& block = blocks[(size_t)(h % blocks.size())];
+    uint64_t probes = mix(h);
+    for (int i = 0; i < hashesPerKey; i++) {
+        int bit = (int)((probes >> (i * 9)) & 511);
+        if ((block[bit >> 6] & ((uint64_t)1 << (bit & 63))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}// end mightContain()
+
+size_t BloomFilter::size() const {
+    return numKeys;
+}// end size()
+
+size_t BloomFilter::capacity() const {
+    return maxKeys;
+}// end capacity()
@@ -0,0 +1,51 @@
+/*
+  ==============================================================================
+
+    BloomFilter.h
+    Created: 19 Oct 2026 10:02:14am
+    Author:  arago
+
+    Blocked Bloom filter used as a cheap pre-check in front of the HashTable.
+    Each key maps to a single 512-bit (one cache line) block, and all of the
+    key's bits are set inside that block, so a lookup touches one cache line.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class BloomFilter {
+public:
+    // Constructor sizes the filter for roughly 'expectedKeys' distinct keys
+    BloomFilter(size_t expectedKeys = 1 << 16);
+
+    // Add a key to the filter
+    void insert(long key);
+
+    // false means the key was definitely never inserted, true means it might have been
+    bool mightContain(long key) const;
+
+    // Drop every key and resize for 'expectedKeys' distinct keys
+    void reset(size_t expectedKeys);
+
+    // number of keys inserted and the number of keys the filter was sized for
+    size_t size() const;
+    size_t capacity() const;
+
+private:
+    static constexpr int bitsPerKey = 10;
+    static constexpr int hashesPerKey = 7;
+    static constexpr int wordsPerBlock = 8; // 8 * 64 bits = 512 bits = one cache line
+
+    using Block = std::array<uint64_t, wordsPerBlock>;
+
+    static uint64_t mix(uint64_t key);
+
+    std::vector<Block> blocks;
+    size_t numKeys;
+    size_t maxKeys;
+};
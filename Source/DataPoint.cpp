@@ -15,10 +15,10 @@ DataPoint::DataPoint(std::string sd, int t) {
     time = t;
 }// end DataPoint()
 
-int DataPoint::getTime() {
+int DataPoint::getTime() const {
     return time;
 }// end getTime()
 
-std::string DataPoint::getSongId() {
+std::string DataPoint::getSongId() const {
     return songId;
 }// end getSongId()
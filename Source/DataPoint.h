@@ -14,8 +14,8 @@ class DataPoint {
 
 public:
     DataPoint(std::string sd, int t);
-    int getTime();
-    std::string getSongId();
+    int getTime() const;
+    std::string getSongId() const;
 
 private:
     int time;
@@ -0,0 +1,265 @@
+/*
+  ==============================================================================
+
+    Fingerprinter.cpp
+    Created: 19 Oct 2026 1:14:52pm
+    Author:  arago
+
+  ==============================================================================
+*/
+
+#include "Fingerprinter.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <map>
+
+std::unique_ptr<Fingerprinter> Fingerprinter::create(const std::string& profileName) {
+    if (profileName == DefaultProfile::name) {
+        return std::make_unique<ProfileFingerprinter<DefaultProfile>>();
+    }
+    if (profileName == LiveProfile::name) {
+        return std::make_unique<ProfileFingerprinter<LiveProfile>>();
+    }
+    if (profileName == ArchivalProfile::name) {
+        return std::make_unique<ProfileFingerprinter<ArchivalProfile>>();
+    }
+    DBG("unknown analysis profile " << profileName);
+    return nullptr;
+}// end create()
+
+std::vector<std::pair<long, int>> Fingerprinter::fingerprintColumns(const std::vector<std::vector<std::pair<int, int>>>& hashingData) const {
+    std::vector<std::pair<long, int>> fingerprints;
+    fingerprints.reserve(hashingData.size());
+    for (int x = 0; x < (int)hashingData.size(); x++) {
+        // column x is the frame starting at sample x * hopSize, so x is its exact timestamp
+        fingerprints.push_back(std::make_pair(hashColumn(hashingData[x]), x));
+    }
+    return fingerprints;
+}// end fingerprintColumns()
+
+std::vector<float> Fingerprinter::resample(const float* samples, int numSamples, double fromRate, double toRate) {
+    if (fromRate == toRate) {
+        return std::vector<float>(samples, samples + numSamples);
+    }
+    auto speedRatio = fromRate / toRate;
+    std::vector<float> resampled((size_t)(numSamples / speedRatio));
+    juce::LagrangeInterpolator interpolator;
+    interpolator.process(speedRatio, samples, resampled.data(), (int)resampled.size(), numSamples, 0);
+    return resampled;
+}// end resample()
+
+//==============================================================================
+template <typename Profile>
+ProfileFingerprinter<Profile>::ProfileFingerprinter()
+    : fft(fftOrder)
+{
+    prepare(44100.0);
+    reset();
+}// end ProfileFingerprinter()
+
+template <typename Profile>
+void ProfileFingerprinter<Profile>::prepare(double sampleRate) {
+    // set range for data normalization, 20Hz to 20kHz but never past Nyquist, where bins mirror the ones below
+    auto topFrequency = juce::jmin(20000.0, sampleRate / 2.0);
+    auto normalRange = makeRange::withCentre(float((double(fftSize) / sampleRate) * 20.f), float((double(fftSize) / sampleRate) * topFrequency), float((double(fftSize) / sampleRate) * 1000.f));
+    rowBins[0] = 0;
+    for (int y = 1; y < frequencyRows; ++y) {
+        // normalize the data
+        auto normalization = (float)y / frequencyRows;
+        rowBins[y] = juce::jlimit(0, fftSize - 1, (int)normalRange.convertFrom0to1((1 - normalization)));
+    }
+}// end prepare()
+
+template <typename Profile>
+void ProfileFingerprinter<Profile>::reset() {
+    nextFFTBlockReady = false;
+    std::fill(fftData.begin(), fftData.end(), 0.0f);
+    std::fill(fifo.begin(), fifo.end(), 0.0f);
+    fifoIndex = 0;
+}// end reset()
+
+template <typename Profile>
+bool ProfileFingerprinter<Profile>::pushNextSample(float sample) noexcept {
+    // if the fifo contains enough data, set a flag to say
+    // that the next column should now be computed..
+    if (fifoIndex == fftSize) {
+        if (!nextFFTBlockReady)
+        {
+            std::fill(fftData.begin(), fftData.end(), 0.0f);
+            std::copy(fifo.begin(), fifo.end(), fftData.begin());
+            nextFFTBlockReady = true;
+        }
+        fifoIndex = 0;
+    }
+    fifo[(size_t)fifoIndex++] = sample;
+    return nextFFTBlockReady;
+}// end pushNextSample()
+
+template <typename Profile>
+float ProfileFingerprinter<Profile>::gatherRows(std::array<float, frequencyRows>& rowMagnitudes) {
+    // do the fft
+    fft.performFrequencyOnlyForwardTransform(fftData.data());
+    auto maxLevel = juce::FloatVectorOperations::findMinAndMax(fftData.data(), fftSize / 2);
+    rowMagnitudes[0] = 0.0f;
+    for (int y = 1; y < frequencyRows; ++y) {
+        rowMagnitudes[y] = fftData[rowBins[y]];
+    }
+    nextFFTBlockReady = false;
+    return maxLevel.getEnd();
+}// end gatherRows()
+
+template <typename Profile>
+void ProfileFingerprinter<Profile>::nextColumn(std::vector<std::pair<float, int>>& levels, std::vector<std::pair<int, int>>& hashing) {
+    std::array<float, frequencyRows> rowMagnitudes;
+    auto maxLevel = juce::jmax(gatherRows(rowMagnitudes), 1e-5f);
+    // for each frequency row
+    for (int y = 1; y < frequencyRows; ++y) {
+        auto level = juce::jmap(rowMagnitudes[y], 0.0f, maxLevel, 0.0f, 1.0f);
+        // store key points
+        hashing.push_back(std::make_pair((int)rowMagnitudes[y], y));
+        levels.push_back(std::make_pair(level, y));
+    }
+}// end nextColumn()
+
+template <typename Profile>
+long ProfileFingerprinter<Profile>::hashPeaks(Candidates& candidates) const {
+    // the weakest point is never a peak, even when there are fewer distinct values than peaks
+    std::iter_swap(std::min_element(candidates.begin(), candidates.end()), candidates.end() - 1);
+    auto last = candidates.end() - 1;
+
+    // only sort as far as needed to find peaksPerFrame distinct values, strongest first and highest row first on ties
+    std::array<std::pair<int, int>, peaksPerFrame> peakPoints;
+    int numPeaks = 0;
+    auto sorted = candidates.begin();
+    long span = peaksPerFrame;
+    while (numPeaks < peaksPerFrame && sorted != last) {
+        auto sortedEnd = candidates.begin() + std::min<long>(span, last - candidates.begin());
+        std::partial_sort(sorted, sortedEnd, last, std::greater<>());
+        // GRAB UNIQUE VALUES, the first of each value is the one in the highest row
+        for (; sorted != sortedEnd && numPeaks < peaksPerFrame; ++sorted) {
+            if (numPeaks == 0 || peakPoints[numPeaks - 1].first != sorted->first) {
+                peakPoints[numPeaks++] = *sorted;
+            }
+        }
+        // ties took some of the places, sort further
+        span *= 2;
+    }
+
+    // the hash is a sum, so the order of the peaks doesn't change it
+    std::hash<int> hasher;
+    long fingerprint = 0;
+    for (int y = 0; y < numPeaks; y++) {
+        fingerprint += hasher(peakPoints[y].second);
+    }
+    return fingerprint;
+}// end hashPeaks()
+
+template <typename Profile>
+long ProfileFingerprinter<Profile>::hashColumn(const std::vector<std::pair<int, int>>& column) const {
+    Candidates candidates;
+    std::copy_n(column.begin(), candidates.size(), candidates.begin());
+    return hashPeaks(candidates);
+}// end hashColumn()
+
+template <typename Profile>
+std::vector<std::pair<long, int>> ProfileFingerprinter<Profile>::fingerprintSamples(const float* samples, int numSamples, double sampleRate, double indexRate) {
+    // a frame is hopSize samples long, so frames only cover the same stretch of audio at the same rate
+    std::vector<float> resampled;
+    if (sampleRate != indexRate) {
+        resampled = resample(samples, numSamples, sampleRate, indexRate);
+        samples = resampled.data();
+        numSamples = (int)resampled.size();
+    }
+    std::vector<std::pair<long, int>> fingerprints;
+    fingerprints.reserve((size_t)(numSamples / hopSize));
+    std::array<float, frequencyRows> rowMagnitudes;
+    Candidates candidates;
+    prepare(indexRate);
+    reset();
+    for (int position = 0; position < numSamples; position++) {
+        if (pushNextSample(samples[position])) {
+            gatherRows(rowMagnitudes);
+            for (int y = 1; y < frequencyRows; ++y) {
+                candidates[y - 1] = std::make_pair((int)rowMagnitudes[y], y);
+            }
+            // hash each frame as it is read, frame x starts at sample x * hopSize so x is its timestamp
+            fingerprints.push_back(std::make_pair(hashPeaks(candidates), (int)fingerprints.size()));
+        }
+    }
+    return fingerprints;
+}// end fingerprintSamples()
+
+template class ProfileFingerprinter<DefaultProfile>;
+template class ProfileFingerprinter<LiveProfile>;
+template class ProfileFingerprinter<ArchivalProfile>;
+
+//==============================================================================
+std::pair<std::string, int> Fingerprinter::predict(const HashTable& index, const std::vector<std::pair<long, int>>& fingerprints, bool stopEarly) {
+    // number of query fingerprints that agree on each <song, frame offset>
+    std::map<std::pair<std::string, int>, int> votes;
+    // best binned votes seen so far for each song
+    std::map<std::string, int> songVotes;
+    std::string guestimate = "";
+    int guestimate_occurance = 0;
+    std::vector<std::pair<std::string, int>> song_matches;
+    for (auto const& [fingerprint, frame] : fingerprints) {
+        song_matches.clear();
+        if (!index.check(fingerprint, frame, song_matches)) {
+            continue;
+        }
+        for (auto const& [song, offset] : song_matches) {
+            votes[std::make_pair(song, offset)]++;
+            // the new vote counts towards every bin of offsetBinWidth neighbouring offsets that contains 'offset'
+            for (int start = offset - offsetBinWidth + 1; start <= offset; start++) {
+                int binned = 0;
+                for (int d = start; d < start + offsetBinWidth; d++) {
+                    auto it = votes.find(std::make_pair(song, d));
+                    if (it != votes.end()) {
+                        binned += it->second;
+                    }
+                }
+                int& best = songVotes[song];
+                best = std::max(best, binned);
+                if (best > guestimate_occurance) {
+                    guestimate_occurance = best;
+                    guestimate = song;
+                }
+            }
+        }
+        // stop early once one song is clearly ahead of every other song
+        if (stopEarly && guestimate_occurance >= earlyStopVotes) {
+            int runner_up = 0;
+            for (auto const& [song, best] : songVotes) {
+                if (song != guestimate) {
+                    runner_up = std::max(runner_up, best);
+                }
+            }
+            if (guestimate_occurance >= earlyStopRatio * runner_up) {
+                break;
+            }
+        }
+    }
+    return std::make_pair(guestimate, guestimate_occurance);
+}// end predict()
+
+std::string Fingerprinter::ingest(HashTable& index, const std::vector<std::pair<long, int>>& fingerprints, const std::string& name) {
+    // count every vote, the early stop would cap the votes below the duplicate threshold for long songs
+    auto [song, votes] = predict(index, fingerprints, false);
+    // the votes have to cover most of both songs, so a short clip of a long mix (or the other way round) isn't a copy,
+    // and be as many as a confident query match, so a few lucky frames of a very short song aren't either
+    bool coversNewSong = votes * 100 >= duplicatePercent * (int)fingerprints.size();
+    bool coversCatalogSong = votes * 100 >= duplicatePercent * index.getNumFrames(song);
+    if (song.size() && votes >= earlyStopVotes && coversNewSong && coversCatalogSong) {
+        // same audio as 'song', keep one copy of the postings
+        std::string canonical = index.getCanonicalName(song);
+        if (canonical != name) {
+            index.addAlias(name, canonical);
+        }
+        return canonical;
+    }
+    for (auto const& [fingerprint, frame] : fingerprints) {
+        index.insertElement(fingerprint, frame, name);
+    }
+    return name;
+}// end ingest()
@@ -0,0 +1,123 @@
+/*
+  ==============================================================================
+
+    Fingerprinter.h
+    Created: 19 Oct 2026 1:14:52pm
+    Author:  arago
+
+    The FFT, peak picking, hashing and offset voting steps of the algorithm,
+    pulled out of MainComponent so they can run without a window (see MatchServer).
+
+    Fingerprinter is the runtime interface, ProfileFingerprinter implements it
+    for one of the settings in AnalysisProfiles.h. Use Fingerprinter::create()
+    with the profile name a HashTable was built with.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "AnalysisProfiles.h"
+#include "Range.h"
+#include "hashTable.h"
+#include <array>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+class Fingerprinter {
+public:
+    enum
+    {
+        offsetBinWidth = 2, // a query starts part way into a frame, so a true match lands on offset d or d + 1
+        earlyStopVotes = 12, // stop looking up the query once the best song has this many votes...
+        earlyStopRatio = 3, // ...and at least this many times the votes of the next best song
+        duplicatePercent = 40 // a new song is a copy of a catalog song if this percent of its frames, and of the catalog song's, vote for one offset of it
+    };
+
+    virtual ~Fingerprinter() = default;
+
+    // make the fingerprinter for the profile called 'profileName', nullptr if there is no such profile
+    static std::unique_ptr<Fingerprinter> create(const std::string& profileName);
+
+    // settings of the profile this fingerprinter was made for
+    virtual const char* getProfileName() const = 0;
+    virtual int getFrequencyRows() const = 0;
+    virtual int getPeaksPerFrame() const = 0;
+
+    // set the range used to map frequency rows onto FFT bins for audio at 'sampleRate'
+    virtual void prepare(double sampleRate) = 0;
+
+    // clear the fifo before a new file is read
+    virtual void reset() = 0;
+
+    // gives the current FFT block the next sample, returns true once a full block is ready
+    virtual bool pushNextSample(float sample) noexcept = 0;
+
+    // run the FFT on the ready block and fill one column of <level, y> and <fftData (floor), y> pairs
+    virtual void nextColumn(std::vector<std::pair<float, int>>& levels, std::vector<std::pair<int, int>>& hashing) = 0;
+
+    // hash the top peaks of one column of <fftData (floor), y> pairs
+    virtual long hashColumn(const std::vector<std::pair<int, int>>& column) const = 0;
+
+    // hash every column, returns <fingerprint, frame index> pairs
+    std::vector<std::pair<long, int>> fingerprintColumns(const std::vector<std::vector<std::pair<int, int>>>& hashingData) const;
+
+    // the whole pipeline without drawing: mono samples at 'sampleRate' in, <fingerprint, frame index> pairs out.
+    // The samples are resampled to 'indexRate' first, so frame indices line up with a database built at that rate
+    virtual std::vector<std::pair<long, int>> fingerprintSamples(const float* samples, int numSamples, double sampleRate, double indexRate) = 0;
+
+    // mono samples at 'fromRate' resampled to 'toRate'
+    static std::vector<float> resample(const float* samples, int numSamples, double fromRate, double toRate);
+
+    // look the query up in 'index', voting on <song, frame offset>, and return the <song name, votes> with the most votes
+    static std::pair<std::string, int> predict(const HashTable& index, const std::vector<std::pair<long, int>>& fingerprints, bool stopEarly = true);
+
+    // add a song to the catalog, unless it is a near-duplicate (re-encoded or renamed copy) of a song already in it,
+    // in which case 'name' is recorded as an alias of that song. Returns the name the song is known by in 'index'
+    static std::string ingest(HashTable& index, const std::vector<std::pair<long, int>>& fingerprints, const std::string& name);
+};
+
+template <typename Profile>
+class ProfileFingerprinter final : public Fingerprinter {
+public:
+    enum
+    {
+        fftOrder = Profile::fftOrder,
+        fftSize = 1 << fftOrder,
+        hopSize = fftSize, // blocks don't overlap, frame x starts at sample x * hopSize
+        frequencyRows = Profile::frequencyRows,
+        peaksPerFrame = Profile::peaksPerFrame
+    };
+
+    ProfileFingerprinter();
+
+    const char* getProfileName() const override { return Profile::name; }
+    int getFrequencyRows() const override { return frequencyRows; }
+    int getPeaksPerFrame() const override { return peaksPerFrame; }
+
+    void prepare(double sampleRate) override;
+    void reset() override;
+    bool pushNextSample(float sample) noexcept override;
+    void nextColumn(std::vector<std::pair<float, int>>& levels, std::vector<std::pair<int, int>>& hashing) override;
+    long hashColumn(const std::vector<std::pair<int, int>>& column) const override;
+    std::vector<std::pair<long, int>> fingerprintSamples(const float* samples, int numSamples, double sampleRate, double indexRate) override;
+
+private:
+    // <fftData (floor), y> for rows 1 up to frequencyRows, row 0 is never a peak
+    using Candidates = std::array<std::pair<int, int>, frequencyRows - 1>;
+
+    // run the FFT on the ready block and gather the magnitude each frequency row reads, returns the loudest bin
+    float gatherRows(std::array<float, frequencyRows>& rowMagnitudes);
+
+    // hash the rows with the peaksPerFrame highest distinct values, reorders 'candidates'
+    long hashPeaks(Candidates& candidates) const;
+
+    juce::dsp::FFT fft;
+    std::array<int, frequencyRows> rowBins; // FFT bin each frequency row reads, worked out once in prepare()
+    std::array<float, fftSize> fifo;
+    std::array<float, fftSize * 2> fftData;
+    int fifoIndex = 0;
+    bool nextFFTBlockReady = false;
+};
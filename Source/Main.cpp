@@ -8,6 +8,8 @@
 
 #include <JuceHeader.h>
 #include "MainComponent.h"
+#include "MatchServer.h"
+#include "Fingerprinter.h"
 
 //==============================================================================
 class Audio_ProtectApplication  : public juce::JUCEApplication
@@ -25,6 +27,29 @@ public:
     {
         // This method is where you should put your application's initialisation code..
 
+        // "--serve <socket> --index <database file>" runs the headless matching service instead of the window
+        auto args = juce::StringArray::fromTokens (commandLine, true);
+        auto serveArg = args.indexOf ("--serve");
+        if (serveArg >= 0)
+        {
+            if (serveArg + 1 < args.size())
+                startServer (args[serveArg + 1].unquoted(), args);
+            else
+                failWithUsage ("--serve needs a socket path");
+            return;
+        }
+
+        // "--build <folder of .wav files> --index <database file> [--profile <name>] [--rate <Hz>]" fingerprints a folder into a new database
+        auto buildArg = args.indexOf ("--build");
+        if (buildArg >= 0)
+        {
+            if (buildArg + 1 < args.size())
+                buildIndex (juce::File::getCurrentWorkingDirectory().getChildFile (args[buildArg + 1].unquoted()), args);
+            else
+                failWithUsage ("--build needs a folder of .wav files");
+            return;
+        }
+
         mainWindow.reset (new MainWindow (getApplicationName()));
     }
 
@@ -33,6 +58,111 @@ public:
         // Add your application's shutdown code here..
 
         mainWindow = nullptr; // (deletes our window)
+        matchServer = nullptr;
+    }
+
+    void startServer (const juce::String& socketPath, const juce::StringArray& args)
+    {
+        auto indexArg = args.indexOf ("--index");
+        if (indexArg < 0 || indexArg + 1 >= args.size())
+        {
+            failWithUsage ("--index <database file> is required");
+            return;
+        }
+        juce::File fingerprintData (juce::File::getCurrentWorkingDirectory().getChildFile (args[indexArg + 1].unquoted()));
+        if (! fingerprintData.existsAsFile())
+        {
+            failWithUsage ("no database at " + fingerprintData.getFullPathName());
+            return;
+        }
+
+        // "--cache <file>" keeps FILE and PCM results between runs, next to the database by default
+        juce::File cacheFile = fingerprintData.getSiblingFile ("query_cache.txt");
+        auto cacheArg = args.indexOf ("--cache");
+        if (cacheArg >= 0 && cacheArg + 1 < args.size())
+            cacheFile = juce::File::getCurrentWorkingDirectory().getChildFile (args[cacheArg + 1].unquoted());
+
+        matchServer.reset (new MatchServer (socketPath));
+        matchServer->loadCache (cacheFile);
+        if (! matchServer->loadIndex (fingerprintData))
+            failWithUsage ("couldn't load the database " + fingerprintData.getFullPathName()
+                           + " (it was made before frame timestamps, is missing its profile or rate, or names an unknown analysis profile)");
+        else if (! matchServer->start())
+            failWithUsage ("couldn't listen on " + socketPath);
+    }
+
+    void buildIndex (const juce::File& audioFolder, const juce::StringArray& args)
+    {
+        auto indexArg = args.indexOf ("--index");
+        if (indexArg < 0 || indexArg + 1 >= args.size())
+        {
+            failWithUsage ("--index <database file> is required");
+            return;
+        }
+        juce::File fingerprintData (juce::File::getCurrentWorkingDirectory().getChildFile (args[indexArg + 1].unquoted()));
+
+        // the profile and rate are fixed once the database is built, every query is analysed the same way
+        std::string profileName = DefaultProfile::name;
+        auto profileArg = args.indexOf ("--profile");
+        if (profileArg >= 0 && profileArg + 1 < args.size())
+            profileName = args[profileArg + 1].unquoted().toStdString();
+        auto fingerprinter = Fingerprinter::create (profileName);
+        if (fingerprinter == nullptr)
+        {
+            failWithUsage ("unknown analysis profile " + juce::String (profileName));
+            return;
+        }
+
+        double sampleRate = 44100.0;
+        auto rateArg = args.indexOf ("--rate");
+        if (rateArg >= 0 && rateArg + 1 < args.size())
+            sampleRate = args[rateArg + 1].getDoubleValue();
+        if (sampleRate < 8000.0 || sampleRate > 192000.0)
+        {
+            failWithUsage ("--rate must be between 8000 and 192000");
+            return;
+        }
+
+        HashTable hashtable;
+        hashtable.setProfile (fingerprinter->getProfileName());
+        hashtable.setSampleRate (sampleRate);
+
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats(); // allows for .wav and .aaif files
+        for (auto& file : audioFolder.findChildFiles (juce::File::findFiles, false, "*.wav"))
+        {
+            std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (file));
+            if (reader == nullptr || reader->lengthInSamples / reader->sampleRate >= 600)
+            {
+                // limits input file to 600 seconds -> 10 mins
+                juce::Logger::writeToLog ("audio_protect: skipped " + file.getFileName());
+                continue;
+            }
+            juce::AudioSampleBuffer fileBuffer ((int) reader->numChannels, (int) reader->lengthInSamples);
+            reader->read (&fileBuffer, 0, (int) reader->lengthInSamples, 0, true, true);
+            auto fingerprints = fingerprinter->fingerprintSamples (fileBuffer.getReadPointer (0), fileBuffer.getNumSamples(), reader->sampleRate, sampleRate);
+            auto songName = file.getFileName().toStdString();
+            auto canonical = Fingerprinter::ingest (hashtable, fingerprints, songName);
+            juce::Logger::writeToLog ("audio_protect: " + file.getFileName() + (canonical == songName ? juce::String() : " is a copy of " + juce::String (canonical)));
+        }
+
+        if (! hashtable.saveToFile (fingerprintData))
+        {
+            failWithUsage ("couldn't write the database " + fingerprintData.getFullPathName());
+            return;
+        }
+        quit();
+    }
+
+    // print why the command line couldn't be run and exit with an error, the Logger goes to stderr when there's no window
+    void failWithUsage (const juce::String& reason)
+    {
+        juce::Logger::writeToLog ("audio_protect: " + reason);
+        juce::Logger::writeToLog ("usage: --serve <socket> --index <database file> [--cache <file>]");
+        juce::Logger::writeToLog ("       --build <folder of .wav files> --index <database file> [--profile default|live|archival] [--rate <Hz>]");
+        matchServer = nullptr;
+        setApplicationReturnValue (1);
+        quit();
     }
 
     //==============================================================================
@@ -99,6 +229,7 @@ public:
 
 private:
     std::unique_ptr<MainWindow> mainWindow;
+    std::unique_ptr<MatchServer> matchServer;
 };
 
 //==============================================================================
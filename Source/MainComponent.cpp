@@ -7,7 +7,7 @@ MainComponent::MainComponent()
     :
     openButton("Fingerprint a New File"),
     checkButton("Audio Protect an Existing File"),
-    fft(fftOrder),
+    fingerprinter(Fingerprinter::create(DefaultProfile::name)),
     spectrogramImage(juce::Image::RGB, 660, 330, true),
     constellationImage(juce::Image::RGB, 660, 330, true),
     combinedImage(juce::Image::RGB, 1360, 330, true),
@@ -21,13 +21,14 @@ MainComponent::MainComponent()
 
     setOpaque(true);
 
+    // load the database first, it decides which analysis profile is made and the rate drawSpectrogram() prepare()s it for
+    populateFingerprints();
+
     setAudioChannels(1, 0);
 
     setSize(1400, 900);
 
     formatManager.registerBasicFormats(); // allows for .wav and .aaif files
-
-    populateFingerprints();
 }
 
 MainComponent::~MainComponent() {
@@ -38,8 +39,7 @@ MainComponent::~MainComponent() {
 //==============================================================================
 void MainComponent::prepareToPlay(int samplesPerBlockExpected, double sampleRate) {
     // no audio play back
-    // set range for data normalization
-    normalRange = makeRange::withCentre(float((double(fftSize) / sampleRate) * 20.f), float((double(fftSize) / sampleRate) * 20000.f), float((double(fftSize) / sampleRate) * 1000.f));
+    // files are analysed at the database's rate, drawSpectrogram() prepares the fingerprinter
 }
 
 void MainComponent::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) {
@@ -84,6 +84,7 @@ void MainComponent::resized() {
 
 void MainComponent::populateFingerprints() {
     // UNCOMMENT THIS PORTION OF THE CODE TO POPULATE A TEXT FILE WITH FFT DATA (THE DATABASE)
+    // (or run the app with --build, see Main.cpp, to pick the profile and write the file directly)
     //*******************************************************************************
     // 
     //draw = false;
@@ -98,82 +99,35 @@ void MainComponent::populateFingerprints() {
     // 
     //*******************************************************************************
     const juce::File fingerprintData("C:/Users/arago/OneDrive/Desktop/Spring2022/CSCI490/formated_database.txt");
-    if (!fingerprintData.existsAsFile()) {
-        DBG(fingerprintData.getFileName() << " doesnt not exist");
-        return;  // file doesn't exist
+    if (!hashtable.loadFromFile(fingerprintData)) {
+        // file doesn't exist, failed to open or was made before frame timestamps
+        currentStatus = "Couldn't load the database, rebuild it with --build (see README).";
+        return;
     }
-    juce::FileInputStream inputStream(fingerprintData);
-    if (!inputStream.openedOk()) {
-        DBG("failed to open " << inputStream.getFile().getFileName());
-        return;  // failed to open
+    // analyse files the same way the database was built
+    if (auto profileFingerprinter = Fingerprinter::create(hashtable.getProfile())) {
+        fingerprinter = std::move(profileFingerprinter);
     }
-    bool hasFingerprint = false;
-    while (!inputStream.isExhausted()) {
-        std::istringstream ss(inputStream.readNextLine().toStdString());
-        std::string word;
-        long fp;
-        ss >> word;
-        if (word == "*") {
-            hasFingerprint = true;
-        }
-        else if (hasFingerprint) {
-            fp = std::stol(word);
-            ss = (std::istringstream)inputStream.readNextLine().toStdString();
-            ss >> word;
-            int num_prints = std::stoi(word);
-            //DBG(word);
-            for (int i = 0; i < num_prints; i++) {
-                ss = (std::istringstream)inputStream.readNextLine().toStdString();
-                ss >> word;
-                //DBG(word);
-                std::string name = word;
-                ss >> word;
-                int seconds = std::stoi(word);
-                hashtable.insertElement(fp, seconds, name);
-            }
-            hasFingerprint = false;
-        }
+    else {
+        currentStatus = "Unknown analysis profile " + hashtable.getProfile();
+        return;
     }
+    // not the service's query_cache.txt, ResultCache only locks within one process
+    resultCache.load(fingerprintData.getSiblingFile("window_query_cache.txt"));
     currentStatus = "Populated the Database with 25 Songs.";
 }// end populateFingerprints()
 
-//gives the current FFT block the next sample data
-void MainComponent::pushNextSampleIntoFifo(float sample) noexcept {
-    // if the fifo contains enough data, set a flag to say
-    // that the next line should now be rendered..
-    if (fifoIndex == fftSize) {
-        if (!nextFFTBlockReady)
-        {
-            std::fill(fftData.begin(), fftData.end(), 0.0f);
-            std::copy(fifo.begin(), fifo.end(), fftData.begin());
-            nextFFTBlockReady = true;
-        }
-        fifoIndex = 0;
-    }
-    fifo[(size_t)fifoIndex++] = sample;
-}// pushNextSampleIntoFifo()
-
 void MainComponent::drawNextLineOfSpectrogram() {
-    auto imageHeight = spectrogramImage.getHeight();
-    // do the fft
-    fft.performFrequencyOnlyForwardTransform(fftData.data());
-    auto maxLevel = juce::FloatVectorOperations::findMinAndMax(fftData.data(), fftSize / 2);
     // prepare vectors for push_back()
     constellationData.resize(pixelX + 1);
     hashingData.resize(pixelX + 1);
-    // for each pixel on the y-axis
-    for (auto y = 1; y < imageHeight; ++y) {
-        // normalize the data
-        auto normalization = (float)y / imageHeight;
-        auto fftDataIndex = normalRange.convertFrom0to1((1 - normalization));
-        auto level = juce::jmap(fftData[fftDataIndex], 0.0f, juce::jmax(maxLevel.getEnd(), 1e-5f), 0.0f, 1.0f);
-        // store key points
-        hashingData[pixelX].push_back(std::make_pair(fftData[fftDataIndex], y)); // implicit caste to int for fftData[fftDataIndex]
-        constellationData[pixelX].push_back(std::make_pair(level, y));
-        if (draw) {
-            // draw the image
-            spectrogramImage.setPixelAt(pixelX, y, juce::Colour::fromHSV(level, 1.0f, level, 1.0f));
-            combinedImage.setPixelAt(pixelX, y, juce::Colour::fromHSV(level, 1.0f, level, 1.0f));
+    // do the fft, one <level, y> pair per frequency row of the profile
+    fingerprinter->nextColumn(constellationData[pixelX], hashingData[pixelX]);
+    if (draw) {
+        // draw the image
+        for (auto const& [level, y] : constellationData[pixelX]) {
+            spectrogramImage.setPixelAt(pixelX, rowToPixelY(y), juce::Colour::fromHSV(level, 1.0f, level, 1.0f));
+            combinedImage.setPixelAt(pixelX, rowToPixelY(y), juce::Colour::fromHSV(level, 1.0f, level, 1.0f));
         }
     }
 }// drawNextLineOfSpectrogram()
@@ -182,108 +136,45 @@ void MainComponent::drawConstellationImage() {
     for (int x = 0; x < (int)constellationData.size(); x++) {
         // sort to get the most prominent points
         std::sort(constellationData[x].begin(), constellationData[x].end());
-        // take the top 5-10 'strongest'/'robust' points
-        std::vector<std::pair<float, int>>::const_iterator first = constellationData[x].end() - 5;
+        // take the top 'strongest'/'robust' points, as many as the profile hashes
+        int numPeaks = std::min(fingerprinter->getPeaksPerFrame(), (int)constellationData[x].size());
+        std::vector<std::pair<float, int>>::const_iterator first = constellationData[x].end() - numPeaks;
         std::vector<std::pair<float, int>>::const_iterator last = constellationData[x].end();
         std::vector<std::pair<float, int>> peakPoints(first, last);
         // draw these points on the image
         if (draw) {
             for (int y = 0; y < (int)peakPoints.size(); y++) {
                 //DBG(y << " PixelX: " << x << " PixelY: " << peakPoints[y].second << " FrequencyLevel: " << peakPoints[y].first);
-                constellationImage.setPixelAt(x, peakPoints[y].second, juce::Colours::white);
-                combinedImage.setPixelAt(x, peakPoints[y].second, juce::Colours::white);
+                constellationImage.setPixelAt(x, rowToPixelY(peakPoints[y].second), juce::Colours::white);
+                combinedImage.setPixelAt(x, rowToPixelY(peakPoints[y].second), juce::Colours::white);
             }
         }
     }
 }// end constellationImage()
 
-void MainComponent::generateFingerprint() {
-    int frames_per_second = std::floor(hashingData.size() / duration);
-    int seconds_passed = 0;
-    for (int x = 0; x < (int)hashingData.size(); x += frames_per_second) {
-        // Every 1 second in the data, I will only fingerprint these points
-        // sort to get the most prominent points (peak frequency points)
-        std::sort(hashingData[x].begin(), hashingData[x].end());
-        std::vector<std::pair<int, int>> peakPoints;
-        int i = 1;
-        // GRAB UNIQUE VALUES from sorted hashingdata[], take the top 5 'strongest'/'robust' points
-        while (peakPoints.size() < 5 && (hashingData[x].end() - i) != hashingData[x].begin()) {
-            int searchVal = (hashingData[x].end() - i)->first;
-            //DBG("Is " << searchVal << " in the vector?");
-            if (std::find_if(peakPoints.begin(), peakPoints.end(), [searchVal](const auto& pair) { return pair.first == searchVal; }) == peakPoints.end()) {
-                // insert if it isnt already a peak point
-                peakPoints.push_back(std::make_pair((hashingData[x].end() - i)->first, (hashingData[x].end() - i)->second));
-            }
-            i++;
-        }
-
-        // sort to get in order of increasing y value ... 0->1->2->3 which is from .second() of the pair
-        std::sort(peakPoints.begin(), peakPoints.end(),
-            [](const std::pair<int, int>& x, const std::pair<int, int>& y)
-        {
-            return x.second < y.second;
-        });
-
-        // hash these peak frequency values in their correct increasing order "hash a bin"
-        std::hash<int> hasher;
-        long fingerprint = 0;
-        for (int y = 0; y < (int)peakPoints.size(); y++) {
-            //DBG("Seconds Passed: " << seconds_passed << " => " << y << " PixelX: " << x << " PixelY: " << peakPoints[y].second << " Frequency: " << peakPoints[y].first);
-            fingerprint += hasher(peakPoints[y].second);
-        }
-        //DBG("fingerprint for pixelX = " << x << " is " << fingerprint);
+int MainComponent::rowToPixelY(int row) const {
+    // the images are as tall as the default profile has rows, scale the other profiles' rows to fit
+    return row * spectrogramImage.getHeight() / fingerprinter->getFrequencyRows();
+}// end rowToPixelY()
 
-        if (draw) {
-            hashtable.insertElement(fingerprint, seconds_passed, song_name);
-        }
-        else {
-            std::vector<std::pair<std::string, int>> song_matches;
-            if (hashtable.check(fingerprint, seconds_passed, song_matches)) {
-                potential_matches.push_back(song_matches);
-            }
+void MainComponent::generateFingerprint() {
+    // fingerprint every frame, timestamped by its frame index
+    query_fingerprints = fingerprinter->fingerprintColumns(hashingData);
+    if (draw) {
+        // re-encoded or renamed copies of a catalog song are recorded as aliases instead of being inserted again
+        std::string canonical = Fingerprinter::ingest(hashtable, query_fingerprints, song_name);
+        if (canonical != song_name) {
+            currentStatus = "Fingerprinted " + song_name + " as a copy of " + canonical;
         }
-
-        fingerprint = 0;
-        seconds_passed++;
+        query_fingerprints.clear();
     }
     //hashtable.printAll();
 }// end generateFingerprint()
 
 void MainComponent::makePrediction() {
-    // prepare map for sorting and indexing predictions
-    std::map<int, std::vector<std::string>> matches;
-    //sort through potential matches and bin them by their offset value
-    for (int i = 0; i < potential_matches.size(); i++) {
-        for (int j = 0; j < potential_matches[i].size(); j++) {
-            matches[potential_matches[i][j].second].push_back(potential_matches[i][j].first);
-        }
-    }
-
-    std::string guestimate = "";
-    int guestimate_occurance = 1;
-    // loop through all of the offsets
-    for (auto it = matches.begin(); it != matches.end(); it++) {
-        // if a bin contains enough songs to potentially changhe our guess, look at songs in the bin
-        if (it->second.size() >= guestimate_occurance) {
-            // will strack accurance of song and its name with map
-            std::map<string, int> occurence;
-            auto it2 = it;
-            // for this offset AND the next 3 offsets (due to JUCE bad timing functions)
-            for (int i = 0; i < 4 && it2 != matches.end(); it2++, i++) {
-                // track how aften a song occures for that given offset
-                for (auto dp : it2->second) {
-                    occurence[dp]++;
-                }
-            }
-            // look for the most common occurance and this will be our current best guess
-            for (auto it3 : occurence) {
-                if (it3.second >= guestimate_occurance) {
-                    guestimate_occurance = it3.second;
-                    guestimate = it3.first;
-                }
-            }
-        }
-    }
+    auto prediction = Fingerprinter::predict(hashtable, query_fingerprints);
+    resultCache.store(queryDigest, hashtable.getVersion(), prediction);
+    std::string guestimate = prediction.first;
     currentStatus = "Detected " + guestimate;
     //DBG(guestimate);
 }// end makePrediction()
@@ -324,6 +215,22 @@ void MainComponent::readInFileFFT(const juce::File& file) {
                 fileBuffer.setSize(reader->numChannels, reader->lengthInSamples);
                 reader->read(&fileBuffer, 0, reader->lengthInSamples, 0, true, true);
                 position = 0;
+                if (!draw) {
+                    // the same audio was checked before against this database, skip the analysis
+                    queryDigest = ResultCache::digest(fileBuffer.getReadPointer(0), fileBuffer.getNumSamples(), reader->sampleRate);
+                    std::pair<std::string, int> cached;
+                    if (resultCache.lookup(queryDigest, hashtable.getVersion(), cached)) {
+                        currentStatus = "Detected " + cached.first;
+                        repaint();
+                        return;
+                    }
+                }
+                if (reader->sampleRate != hashtable.getSampleRate()) {
+                    // frame indices only line up with the database's at the rate it was built at
+                    auto resampled = Fingerprinter::resample(fileBuffer.getReadPointer(0), fileBuffer.getNumSamples(), reader->sampleRate, hashtable.getSampleRate());
+                    fileBuffer.setSize(1, (int)resampled.size());
+                    fileBuffer.copyFrom(0, 0, resampled.data(), (int)resampled.size());
+                }
                 drawSpectrogram();
             }
         }
@@ -335,12 +242,11 @@ void MainComponent::drawSpectrogram() {
     // reset fft variables
     position = 0;
     pixelX = 0;
-    nextFFTBlockReady = false;
-    std::fill(fftData.begin(), fftData.end(), 0.0f);
-    std::fill(fifo.begin(), fifo.end(), 0.0f);
-    fifoIndex = 0;
-    std::vector<std::vector<std::pair<std::string, int>>> new_one;
-    potential_matches = new_one;
+    fingerprinter->prepare(hashtable.getSampleRate());
+    fingerprinter->reset();
+    query_fingerprints.clear();
+    constellationData.clear();
+    hashingData.clear();
 
     //clear the images
     spectrogramImage.clear(spectrogramImage.getBounds(), juce::Colours::black);
@@ -349,10 +255,8 @@ void MainComponent::drawSpectrogram() {
 
     //for each sample in the file buffer
     while (position < fileBuffer.getNumSamples()) {
-        pushNextSampleIntoFifo(fileBuffer.getSample(0, position));
-        if (nextFFTBlockReady) {
+        if (fingerprinter->pushNextSample(fileBuffer.getSample(0, position))) {
             drawNextLineOfSpectrogram();
-            nextFFTBlockReady = false;
             pixelX += 1;
         }
         position++;
@@ -361,7 +265,7 @@ void MainComponent::drawSpectrogram() {
     drawConstellationImage();
     generateFingerprint();
     // make predictions
-    if (potential_matches.size() && !draw) {
+    if (query_fingerprints.size() && !draw) {
         makePrediction();
     }
     repaint();
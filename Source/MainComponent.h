@@ -3,6 +3,8 @@
 #include <JuceHeader.h>
 #include "Range.h"
 #include "hashTable.h"
+#include "Fingerprinter.h"
+#include "ResultCache.h"
 #include <algorithm>
 #include <vector>
 #include <string>
@@ -11,12 +13,6 @@ using Range = juce::NormalisableRange<float>;
 
 class MainComponent  : public juce::AudioAppComponent {
 public:
-    enum
-    {
-        fftOrder = 13,
-        fftSize = 1 << fftOrder
-    };
-
     //==============================================================================
     MainComponent();
     ~MainComponent() override;
@@ -29,11 +25,11 @@ public:
     //==============================================================================
     void openButtonClicked();
     void checkButtonClicked();
-    void pushNextSampleIntoFifo(float sample) noexcept;
     void drawNextLineOfSpectrogram();
     void readInFileFFT(const juce::File& file);
     void drawSpectrogram();
     void drawConstellationImage();
+    int rowToPixelY(int row) const;
     void generateFingerprint();
     void populateFingerprints();
     void makePrediction();
@@ -51,22 +47,20 @@ private:
     juce::AudioSampleBuffer fileBuffer; // stores the data from the file
 
     // Objects and variables for spectrogram
-    juce::dsp::FFT fft;
+    std::unique_ptr<Fingerprinter> fingerprinter; // made for the profile the database was built with
     juce::Image spectrogramImage;
     juce::Image constellationImage;
     juce::Image combinedImage;
 
     // Objects and variables for hashtable
     HashTable hashtable;
-    std::vector<std::vector<std::pair<std::string, int>>> potential_matches;
+    std::vector<std::pair<long, int>> query_fingerprints; // <fingerprint, frame index> of the file being checked
+    ResultCache resultCache;
+    juce::uint64 queryDigest = 0; // digest of the decoded samples of the file being checked
 
     // variables needed for FFT
-    std::array<float, fftSize> fifo;
-    std::array<float, fftSize*2> fftData;
-    std::vector<std::vector<std::pair<float, int>>> constellationData; // vector of pairs where <fftData, y-axis pixel>
-    std::vector<std::vector<std::pair<int, int>>> hashingData; // vector of pairs where <fftData (floor), y-axis pixel>
-    int fifoIndex = 0;
-    bool nextFFTBlockReady = false;
+    std::vector<std::vector<std::pair<float, int>>> constellationData; // vector of pairs where <fftData, frequency row>
+    std::vector<std::vector<std::pair<int, int>>> hashingData; // vector of pairs where <fftData (floor), frequency row>
     float maxValue;
     int position; //position in the array of sample data
     int pixelX;
@@ -75,7 +69,6 @@ private:
     // Other variables required (non-specific to a certain portion of the algorithm)
     double duration;
     bool draw;
-    Range normalRange;
     juce::String currentSizeAsString;
     std::string currentStatus;
     std::string song_name;
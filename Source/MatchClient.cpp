@@ -0,0 +1,213 @@
+/*
+  ==============================================================================
+
+    MatchClient.cpp
+    Created: 19 Oct 2026 4:22:45pm
+    Author:  arago
+
+  ==============================================================================
+*/
+
+#include "MatchClient.h"
+#include <JuceHeader.h>
+
+#if ! JUCE_WINDOWS
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+MatchClient::MatchClient() {
+}// end MatchClient()
+
+MatchClient::~MatchClient() {
+    disconnect();
+}// end ~MatchClient()
+
+bool MatchClient::connect(const std::string& socketPath) {
+    disconnect();
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        return false;  // path too long for a unix socket
+    }
+    std::strcpy(address.sun_path, socketPath.c_str());
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return false;
+    }
+   #ifdef SO_NOSIGPIPE
+    // macOS has no MSG_NOSIGNAL, a server that went away must not kill the calling process
+    int noSigPipe = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+   #endif
+    if (::connect(fd, (sockaddr*)&address, sizeof(address)) != 0) {
+        disconnect();
+        return false;
+    }
+    return true;
+}// end connect()
+
+void MatchClient::disconnect() {
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+    buffer.clear();
+}// end disconnect()
+
+bool MatchClient::isConnected() const {
+    return fd >= 0;
+}// end isConnected()
+
+MatchResult MatchClient::matchFile(const std::string& path) {
+    std::string request = "FILE " + path + "\n";
+    if (!sendAll(request.data(), request.size())) {
+        MatchResult result;
+        result.error = "not connected";
+        return result;
+    }
+    return readResponse();
+}// end matchFile()
+
+MatchResult MatchClient::matchHashes(const std::vector<std::pair<long, int>>& fingerprints) {
+    std::ostringstream request;
+    request << "HASHES " << fingerprints.size() << "\n";
+    for (auto const& [fingerprint, frame] : fingerprints) {
+        request << fingerprint << " " << frame << "\n";
+    }
+    std::string data = request.str();
+    if (!sendAll(data.data(), data.size())) {
+        MatchResult result;
+        result.error = "not connected";
+        return result;
+    }
+    return readResponse();
+}// end matchHashes()
+
+MatchResult MatchClient::matchPcm(const float* samples, int numSamples, double sampleRate) {
+    std::ostringstream header;
+    header << "PCM " << sampleRate << " " << numSamples << "\n";
+    std::string data = header.str();
+    if (!sendAll(data.data(), data.size()) || !sendAll((const char*)samples, (size_t)numSamples * sizeof(float))) {
+        MatchResult result;
+        result.error = "not connected";
+        return result;
+    }
+    return readResponse();
+}// end matchPcm()
+
+bool MatchClient::sendAll(const char* data, size_t size) {
+    // a closed connection shows up as an error (EPIPE) instead of SIGPIPE, so it ends up as "not connected"
+   #ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL;
+   #else
+    const int flags = 0;
+   #endif
+    while (fd >= 0 && size > 0) {
+        ssize_t count = send(fd, data, size, flags);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            disconnect();
+            return false;
+        }
+        data += count;
+        size -= (size_t)count;
+    }
+    return fd >= 0;
+}// end sendAll()
+
+MatchResult MatchClient::readResponse() {
+    MatchResult result;
+    // every response is a single line
+    size_t lineEnd;
+    while ((lineEnd = buffer.find('\n')) == std::string::npos) {
+        char chunk[4096];
+        ssize_t count = fd >= 0 ? recv(fd, chunk, sizeof(chunk), 0) : -1;
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            disconnect();
+            result.error = "connection closed";
+            return result;
+        }
+        buffer.append(chunk, (size_t)count);
+    }
+    std::string line = buffer.substr(0, lineEnd);
+    buffer.erase(0, lineEnd + 1);
+
+    std::istringstream ss(line);
+    std::string word;
+    ss >> word;
+    if (word == "MATCH") {
+        ss >> result.votes;
+        std::getline(ss >> std::ws, result.song);
+        result.ok = true;
+    }
+    else if (word == "NOMATCH") {
+        result.ok = true;
+    }
+    else {
+        std::getline(ss >> std::ws, result.error);
+        if (result.error.empty()) {
+            result.error = "bad response: " + line;
+        }
+    }
+    return result;
+}// end readResponse()
+
+#else
+
+// unix domain sockets aren't available here, every request fails like the server does
+
+static MatchResult notSupported() {
+    MatchResult result;
+    result.error = "not supported on this platform";
+    return result;
+}// end notSupported()
+
+MatchClient::MatchClient() {
+}// end MatchClient()
+
+MatchClient::~MatchClient() {
+}// end ~MatchClient()
+
+bool MatchClient::connect(const std::string&) {
+    return false;
+}// end connect()
+
+void MatchClient::disconnect() {
+    buffer.clear();
+}// end disconnect()
+
+bool MatchClient::isConnected() const {
+    return false;
+}// end isConnected()
+
+MatchResult MatchClient::matchFile(const std::string&) {
+    return notSupported();
+}// end matchFile()
+
+MatchResult MatchClient::matchHashes(const std::vector<std::pair<long, int>>&) {
+    return notSupported();
+}// end matchHashes()
+
+MatchResult MatchClient::matchPcm(const float*, int, double) {
+    return notSupported();
+}// end matchPcm()
+
+bool MatchClient::sendAll(const char*, size_t) {
+    return false;
+}// end sendAll()
+
+MatchResult MatchClient::readResponse() {
+    return notSupported();
+}// end readResponse()
+
+#endif
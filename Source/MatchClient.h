@@ -0,0 +1,52 @@
+/*
+  ==============================================================================
+
+    MatchClient.h
+    Created: 19 Oct 2026 4:22:45pm
+    Author:  arago
+
+    Small blocking client for the MatchServer socket protocol (unix only, like
+    the server, on Windows every request fails with "not supported on this
+    platform"). One client holds one connection, use one client per thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <string>
+#include <utility>
+#include <vector>
+
+struct MatchResult {
+    bool ok = false;       // the server answered, check 'song' to see if anything matched
+    std::string song;      // empty when nothing matched
+    int votes = 0;
+    std::string error;     // set when 'ok' is false
+};
+
+class MatchClient {
+public:
+    MatchClient();
+    ~MatchClient();
+
+    // connect to a MatchServer listening on 'socketPath'
+    bool connect(const std::string& socketPath);
+    void disconnect();
+    bool isConnected() const;
+
+    // ask the server to read and fingerprint an audio file on this host
+    MatchResult matchFile(const std::string& path);
+
+    // match <fingerprint, frame index> pairs that were already computed (see Fingerprinter::fingerprintColumns)
+    MatchResult matchHashes(const std::vector<std::pair<long, int>>& fingerprints);
+
+    // fingerprint raw mono samples on the server
+    MatchResult matchPcm(const float* samples, int numSamples, double sampleRate);
+
+private:
+    bool sendAll(const char* data, size_t size);
+    MatchResult readResponse();
+
+    int fd = -1;
+    std::string buffer; // bytes received past the end of the last response
+};
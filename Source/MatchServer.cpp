@@ -0,0 +1,438 @@
+/*
+  ==============================================================================
+
+    MatchServer.cpp
+    Created: 19 Oct 2026 3:40:07pm
+    Author:  arago
+
+  ==============================================================================
+*/
+
+#include "MatchServer.h"
+#include "Fingerprinter.h"
+
+#if ! JUCE_WINDOWS
+
+#include <cerrno>
+#include <csignal>
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static void setNonBlocking(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}// end setNonBlocking()
+
+MatchServer::MatchServer(const juce::String& path, int numWorkers)
+    : juce::Thread("MatchServer"),
+    socketPath(path),
+    workers(juce::jmax(1, numWorkers))
+{
+}// end MatchServer()
+
+MatchServer::~MatchServer() {
+    signalThreadShouldExit();
+    wake();
+    stopThread(2000);
+    workers.removeAllJobs(true, 10000);
+    for (auto& [id, connection] : connections) {
+        close(connection.fd);
+    }
+    if (listenFd >= 0) {
+        close(listenFd);
+        unlink(socketPath.toRawUTF8());
+    }
+    if (wakePipe[0] >= 0) {
+        close(wakePipe[0]);
+        close(wakePipe[1]);
+    }
+}// end ~MatchServer()
+
+bool MatchServer::loadIndex(const juce::File& fingerprintData) {
+    if (!index.loadFromFile(fingerprintData)) {
+        return false;
+    }
+    // every FILE and PCM request would fail, so refuse to start instead
+    if (Fingerprinter::create(index.getProfile()) == nullptr) {
+        return false;
+    }
+    return true;
+}// end loadIndex()
+
+void MatchServer::loadCache(const juce::File& cacheFile) {
+    cache.load(cacheFile);
+}// end loadCache()
+
+bool MatchServer::start() {
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+    if (socketPath.getNumBytesAsUTF8() >= sizeof(address.sun_path)) {
+        DBG("socket path is too long: " << socketPath);
+        return false;
+    }
+    std::strcpy(address.sun_path, socketPath.toRawUTF8());
+
+    // a client hanging up mid write shouldn't kill the server
+    std::signal(SIGPIPE, SIG_IGN);
+
+    if (pipe(wakePipe) != 0) {
+        DBG("failed to create wake pipe");
+        return false;
+    }
+    setNonBlocking(wakePipe[0]);
+    setNonBlocking(wakePipe[1]);
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        DBG("failed to create socket");
+        return false;
+    }
+    // remove a socket left behind by a previous run
+    unlink(address.sun_path);
+    if (bind(listenFd, (sockaddr*)&address, sizeof(address)) != 0 || listen(listenFd, SOMAXCONN) != 0) {
+        DBG("failed to listen on " << socketPath << ": " << std::strerror(errno));
+        close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    setNonBlocking(listenFd);
+    startThread();
+    return true;
+}// end start()
+
+void MatchServer::wake() {
+    if (wakePipe[1] >= 0) {
+        char byte = 0;
+        (void)write(wakePipe[1], &byte, 1);
+    }
+}// end wake()
+
+void MatchServer::run() {
+    std::vector<pollfd> fds;
+    std::vector<juce::uint64> ids;
+    while (!threadShouldExit()) {
+        // listen socket and wake pipe first, then one entry per client
+        fds.clear();
+        ids.clear();
+        fds.push_back({ listenFd, POLLIN, 0 });
+        fds.push_back({ wakePipe[0], POLLIN, 0 });
+        for (auto& [id, connection] : connections) {
+            short events = connection.doneReading ? 0 : POLLIN;
+            if (connection.out.size()) {
+                events |= POLLOUT;
+            }
+            // a negative fd is skipped by poll, so a hung up client waiting on a result doesn't spin the loop
+            fds.push_back({ (events && !connection.failed) ? connection.fd : -1, events, 0 });
+            ids.push_back(id);
+        }
+
+        if (poll(fds.data(), (nfds_t)fds.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            DBG("poll failed: " << std::strerror(errno));
+            return;
+        }
+
+        if (fds[1].revents & POLLIN) {
+            char drain[64];
+            while (read(wakePipe[0], drain, sizeof(drain)) > 0) {}
+            collectResults();
+        }
+        for (size_t i = 0; i < ids.size(); i++) {
+            auto found = connections.find(ids[i]);
+            if (found == connections.end()) {
+                continue;
+            }
+            Connection& connection = found->second;
+            short revents = fds[i + 2].revents;
+            if (revents & (POLLIN | POLLHUP | POLLERR)) {
+                readFrom(connection);
+            }
+            if (revents & POLLOUT) {
+                writeTo(connection);
+            }
+            while (!connection.pending && parseRequest(ids[i], connection)) {}
+            // drop clients that hung up once nothing is owed to them
+            if (!connection.pending && (connection.failed || (connection.doneReading && connection.out.empty()))) {
+                close(connection.fd);
+                connections.erase(found);
+            }
+        }
+        if (fds[0].revents & POLLIN) {
+            acceptClients();
+        }
+    }
+}// end run()
+
+void MatchServer::acceptClients() {
+    while (true) {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            return;  // no more waiting clients (EAGAIN) or a client gave up
+        }
+        setNonBlocking(fd);
+        Connection connection;
+        connection.fd = fd;
+        connections.emplace(nextConnectionId++, std::move(connection));
+    }
+}// end acceptClients()
+
+void MatchServer::readFrom(Connection& connection) {
+    char buffer[65536];
+    while (true) {
+        ssize_t count = recv(connection.fd, buffer, sizeof(buffer), 0);
+        if (count > 0) {
+            connection.in.append(buffer, (size_t)count);
+            if (connection.in.size() > maxBufferedBytes) {
+                rejectRequest(connection, "request too large");
+                return;
+            }
+        }
+        else if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            return;
+        }
+        else {
+            // hung up or failed
+            connection.doneReading = true;
+            return;
+        }
+    }
+}// end readFrom()
+
+void MatchServer::writeTo(Connection& connection) {
+    while (connection.out.size()) {
+        ssize_t count = send(connection.fd, connection.out.data(), connection.out.size(), 0);
+        if (count > 0) {
+            connection.out.erase(0, (size_t)count);
+        }
+        else if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            return;
+        }
+        else {
+            connection.out.clear();
+            connection.failed = true;
+            return;
+        }
+    }
+}// end writeTo()
+
+bool MatchServer::parseRequest(juce::uint64 id, Connection& connection) {
+    // one request in flight per connection keeps the responses in order
+    if (connection.pending || connection.failed) {
+        return false;
+    }
+    size_t lineEnd = connection.in.find('\n');
+    if (lineEnd == std::string::npos) {
+        if (connection.in.size() > maxLineBytes) {
+            rejectRequest(connection, "request line too long");
+        }
+        return false;  // wait for the rest of the line
+    }
+    if (lineEnd > maxLineBytes) {
+        rejectRequest(connection, "request line too long");
+        return false;
+    }
+    std::istringstream header(connection.in.substr(0, lineEnd));
+    std::string command;
+    header >> command;
+
+    if (command == "FILE") {
+        std::string path;
+        std::getline(header >> std::ws, path);
+        connection.in.erase(0, lineEnd + 1);
+        auto filePath = juce::String::fromUTF8(path.c_str());
+        if (!juce::File::isAbsolutePath(filePath)) {
+            // a relative path would resolve against wherever the service was started
+            connection.out += "ERROR path must be absolute\n";
+            return true;
+        }
+        juce::File file(filePath);
+        connection.pending = true;
+        submit(id, [this, file] { return matchFile(file); });
+    }
+    else if (command == "HASHES") {
+        long count = -1;
+        if (!(header >> count) || count < 0 || count > maxHashes) {
+            // can't tell where the fingerprint lines end, so give up on the stream
+            rejectRequest(connection, "bad HASHES header");
+            return false;
+        }
+        // make sure every fingerprint line has arrived before parsing any of them,
+        // carrying on from where the last poll stopped counting
+        size_t end = std::max(lineEnd, connection.scanPosition);
+        long lines = connection.scannedLines;
+        while (lines < count) {
+            size_t next = connection.in.find('\n', end + 1);
+            if (next == std::string::npos) {
+                connection.scanPosition = end;
+                connection.scannedLines = lines;
+                return false;
+            }
+            end = next;
+            lines++;
+        }
+        connection.scanPosition = 0;
+        connection.scannedLines = 0;
+        std::istringstream body(connection.in.substr(lineEnd + 1, end - lineEnd));
+        connection.in.erase(0, end + 1);
+        std::vector<std::pair<long, int>> fingerprints((size_t)count);
+        for (auto& [fingerprint, frame] : fingerprints) {
+            if (!(body >> fingerprint >> frame)) {
+                connection.out += "ERROR bad HASHES line\n";
+                return true;
+            }
+        }
+        connection.pending = true;
+        submit(id, [this, fingerprints = std::move(fingerprints)] { return matchFingerprints(fingerprints); });
+    }
+    else if (command == "PCM") {
+        double sampleRate = 0;
+        long numSamples = -1;
+        header >> sampleRate >> numSamples;
+        if (header.fail() || sampleRate < minSampleRate || sampleRate > maxSampleRate || numSamples < 0 || numSamples > maxPcmSamples) {
+            // can't tell where the sample data ends, so give up on the stream
+            rejectRequest(connection, "bad PCM header");
+            return false;
+        }
+        size_t numBytes = (size_t)numSamples * sizeof(float);
+        if (connection.in.size() < lineEnd + 1 + numBytes) {
+            return false;  // wait for the rest of the samples
+        }
+        std::vector<float> samples((size_t)numSamples);
+        std::memcpy(samples.data(), connection.in.data() + lineEnd + 1, numBytes);
+        connection.in.erase(0, lineEnd + 1 + numBytes);
+        connection.pending = true;
+        submit(id, [this, samples = std::move(samples), sampleRate] { return matchPcm(samples, sampleRate); });
+    }
+    else {
+        connection.in.erase(0, lineEnd + 1);
+        connection.out += "ERROR unknown request " + command + "\n";
+    }
+    return true;
+}// end parseRequest()
+
+void MatchServer::rejectRequest(Connection& connection, const std::string& message) {
+    // stop reading and drop the client once the error is sent
+    connection.in.clear();
+    connection.out += "ERROR " + message + "\n";
+    connection.doneReading = true;
+}// end rejectRequest()
+
+void MatchServer::submit(juce::uint64 id, std::function<std::string()> job) {
+    workers.addJob([this, id, job = std::move(job)] {
+        std::string response = job();
+        {
+            std::lock_guard<std::mutex> lock(resultLock);
+            results.push_back(std::make_pair(id, response));
+        }
+        wake();
+    });
+}// end submit()
+
+void MatchServer::collectResults() {
+    std::vector<std::pair<juce::uint64, std::string>> finished;
+    {
+        std::lock_guard<std::mutex> lock(resultLock);
+        finished.swap(results);
+    }
+    for (auto& [id, response] : finished) {
+        auto found = connections.find(id);
+        if (found != connections.end()) {
+            found->second.pending = false;
+            found->second.out += response;
+        }
+    }
+}// end collectResults()
+
+std::string MatchServer::matchFingerprints(const std::vector<std::pair<long, int>>& fingerprints) const {
+    return formatPrediction(Fingerprinter::predict(index, fingerprints));
+}// end matchFingerprints()
+
+std::string MatchServer::formatPrediction(const std::pair<std::string, int>& prediction) {
+    if (prediction.first.empty()) {
+        return "NOMATCH\n";
+    }
+    return "MATCH " + std::to_string(prediction.second) + " " + prediction.first + "\n";
+}// end formatPrediction()
+
+std::string MatchServer::matchFile(const juce::File& file) {
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats(); // allows for .wav and .aaif files
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+    if (reader == nullptr) {
+        return "ERROR could not read " + file.getFullPathName().toStdString() + "\n";
+    }
+    double duration = reader->lengthInSamples / reader->sampleRate;
+    if (duration >= 600) {
+        // limits input file to 600 seconds -> 10 mins
+        return "ERROR file is longer than 10 minutes\n";
+    }
+    juce::AudioSampleBuffer fileBuffer((int)reader->numChannels, (int)reader->lengthInSamples);
+    reader->read(&fileBuffer, 0, (int)reader->lengthInSamples, 0, true, true);
+    return matchSamples(fileBuffer.getReadPointer(0), fileBuffer.getNumSamples(), reader->sampleRate);
+}// end matchFile()
+
+std::string MatchServer::matchPcm(const std::vector<float>& samples, double sampleRate) {
+    return matchSamples(samples.data(), (int)samples.size(), sampleRate);
+}// end matchPcm()
+
+std::string MatchServer::matchSamples(const float* samples, int numSamples, double sampleRate) {
+    // audio that was already checked against this version of the index skips the FFT and matching
+    juce::uint64 key = ResultCache::digest(samples, numSamples, sampleRate);
+    std::pair<std::string, int> prediction;
+    if (!cache.lookup(key, index.getVersion(), prediction)) {
+        // analyse the query the same way the database was built
+        auto fingerprinter = Fingerprinter::create(index.getProfile());
+        if (fingerprinter == nullptr) {
+            return "ERROR unknown analysis profile " + index.getProfile() + "\n";
+        }
+        prediction = Fingerprinter::predict(index, fingerprinter->fingerprintSamples(samples, numSamples, sampleRate, index.getSampleRate()));
+        cache.store(key, index.getVersion(), prediction);
+    }
+    return formatPrediction(prediction);
+}// end matchSamples()
+
+#else
+
+// unix domain sockets aren't available here, the server refuses to start
+
+MatchServer::MatchServer(const juce::String& path, int numWorkers)
+    : juce::Thread("MatchServer"),
+    socketPath(path),
+    workers(juce::jmax(1, numWorkers))
+{
+}// end MatchServer()
+
+MatchServer::~MatchServer() {
+}// end ~MatchServer()
+
+bool MatchServer::loadIndex(const juce::File& fingerprintData) {
+    if (!index.loadFromFile(fingerprintData)) {
+        return false;
+    }
+    // every FILE and PCM request would fail, so refuse to start instead
+    if (Fingerprinter::create(index.getProfile()) == nullptr) {
+        return false;
+    }
+    return true;
+}// end loadIndex()
+
+void MatchServer::loadCache(const juce::File& cacheFile) {
+    cache.load(cacheFile);
+}// end loadCache()
+
+bool MatchServer::start() {
+    DBG("MatchServer needs unix domain sockets, which aren't supported on this platform");
+    return false;
+}// end start()
+
+void MatchServer::run() {
+}// end run()
+
+#endif
@@ -0,0 +1,109 @@
+/*
+  ==============================================================================
+
+    MatchServer.h
+    Created: 19 Oct 2026 3:40:07pm
+    Author:  arago
+
+    Long running matching service. The fingerprint database is loaded once and
+    queries are answered over a Unix domain socket, so every consumer on the
+    host shares one copy of the HashTable instead of building its own.
+
+    Protocol (one request at a time per connection, every line ends in '\n'):
+        FILE <absolute path>                fingerprint an audio file on this host
+        HASHES <count>                      followed by <count> lines of "<fingerprint> <frame index>", made
+                                            with the same analysis profile and sample rate as the database
+        PCM <sampleRate> <numSamples>       followed by <numSamples> mono 32 bit floats in host byte order
+    Responses:
+        MATCH <votes> <song name>
+        NOMATCH
+        ERROR <message>
+
+    Requests over the limits below (or a header that can't be parsed) get an
+    ERROR and the connection is closed, since the rest of the stream can't be trusted.
+
+    See MatchClient for a small client for this protocol.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "hashTable.h"
+#include "ResultCache.h"
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+class MatchServer : public juce::Thread {
+public:
+    MatchServer(const juce::String& socketPath, int numWorkers = juce::SystemStats::getNumCpus());
+    ~MatchServer() override;
+
+    // read the fingerprint database, must be called before start(). False if it can't be read
+    // or names an analysis profile this build doesn't have
+    bool loadIndex(const juce::File& fingerprintData);
+
+    // remember FILE and PCM results in 'cacheFile', so repeated audio skips the analysis
+    void loadCache(const juce::File& cacheFile);
+
+    // bind and listen on the socket, then start the event loop thread
+    bool start();
+
+    // the event loop: accepts clients, reads requests and writes back results
+    void run() override;
+
+private:
+    enum
+    {
+        maxLineBytes = 4096,             // longest request line (FILE path or header)
+        maxHashes = 1 << 18,             // most fingerprints in one HASHES request
+        minSampleRate = 8000,
+        maxSampleRate = 192000,
+        maxPcmSamples = 48000 * 600,     // 10 minutes at 48kHz, same limit as the app
+        maxBufferedBytes = maxPcmSamples * 4 + maxLineBytes // a client sending more than one request's worth is dropped
+    };
+
+    struct Connection {
+        int fd;
+        std::string in;   // bytes read but not yet parsed
+        std::string out;  // response bytes not yet written
+        size_t scanPosition = 0;  // newline the HASHES body was counted up to, so it isn't rescanned every poll
+        long scannedLines = 0;    // HASHES body lines found before scanPosition
+        bool pending = false;     // a request is being worked on by the thread pool
+        bool doneReading = false; // the client shut down its side, answer what was sent then drop it
+        bool failed = false;      // the client went away, drop it as soon as nothing is pending
+    };
+
+    void acceptClients();
+    void readFrom(Connection& connection);
+    void writeTo(Connection& connection);
+    bool parseRequest(juce::uint64 id, Connection& connection);
+    void rejectRequest(Connection& connection, const std::string& message);
+    void submit(juce::uint64 id, std::function<std::string()> job);
+    void collectResults();
+    void wake();
+
+    // the request handlers run on the thread pool, the table is only read once loaded
+    std::string matchFingerprints(const std::vector<std::pair<long, int>>& fingerprints) const;
+    std::string matchFile(const juce::File& file);
+    std::string matchPcm(const std::vector<float>& samples, double sampleRate);
+    std::string matchSamples(const float* samples, int numSamples, double sampleRate);
+    static std::string formatPrediction(const std::pair<std::string, int>& prediction);
+
+    HashTable index;
+    ResultCache cache;
+    juce::String socketPath;
+    juce::ThreadPool workers;
+    int listenFd = -1;
+    int wakePipe[2] = { -1, -1 };
+    juce::uint64 nextConnectionId = 0;
+    std::map<juce::uint64, Connection> connections;
+
+    std::mutex resultLock;
+    std::vector<std::pair<juce::uint64, std::string>> results; // finished responses waiting for the event loop
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MatchServer)
+};
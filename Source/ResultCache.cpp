@@ -0,0 +1,214 @@
+/*
+  ==============================================================================
+
+    ResultCache.cpp
+    Created: 19 Oct 2026 6:05:31pm
+    Author:  arago
+
+  ==============================================================================
+*/
+
+#include "ResultCache.h"
+#include <cstring>
+#include <iterator>
+#include <sstream>
+
+ResultCache::ResultCache(int maxEntries)
+    : maxEntries(juce::jmax(1, maxEntries))
+{
+}// end ResultCache()
+
+ResultCache::~ResultCache() {
+    flush();
+}// end ~ResultCache()
+
+void ResultCache::load(const juce::File& cacheFile) {
+    // anything gathered for the previous file goes there first
+    flush();
+    std::lock_guard<std::mutex> guard(lock);
+    file = cacheFile;
+    entries.clear();
+    results.clear();
+    pendingLines.clear();
+    numPending = 0;
+    fileLines = 0;
+    rewriteFile = false;
+    version = 0;
+    if (!file.existsAsFile()) {
+        return;  // nothing cached yet
+    }
+    juce::FileInputStream inputStream(file);
+    if (!inputStream.openedOk()) {
+        DBG("failed to open " << file.getFileName());
+        return;  // failed to open
+    }
+    std::istringstream header(inputStream.readNextLine().toStdString());
+    std::string word;
+    header >> word >> version;
+    if (word != "version") {
+        version = 0;
+        rewriteFile = true;
+        return;  // not a cache file, it gets rewritten on the next write
+    }
+    while (!inputStream.isExhausted()) {
+        std::istringstream ss(inputStream.readNextLine().toStdString());
+        Entry entry;
+        if (ss >> entry.first >> entry.second.second) {
+            std::getline(ss >> std::ws, entry.second.first);
+            fileLines++;
+            // later lines are more recent, so each one goes to the front
+            auto found = results.find(entry.first);
+            if (found != results.end()) {
+                entries.erase(found->second);
+            }
+            entries.push_front(entry);
+            results[entry.first] = entries.begin();
+            if ((int)entries.size() > maxEntries) {
+                results.erase(entries.back().first);
+                entries.pop_back();
+            }
+        }
+    }
+    rewriteFile = fileLines > 2 * maxEntries;
+}// end load()
+
+juce::uint64 ResultCache::digest(const float* samples, int numSamples, double sampleRate) {
+    // FNV style mixing, two samples per step
+    juce::uint64 h = 0xcbf29ce484222325ULL ^ (juce::uint64)numSamples;
+    juce::uint64 rate = 0;
+    std::memcpy(&rate, &sampleRate, sizeof(rate));
+    h = (h ^ rate) * 0x100000001b3ULL;
+    int i = 0;
+    for (; i + 1 < numSamples; i += 2) {
+        juce::uint64 word;
+        std::memcpy(&word, samples + i, sizeof(word));
+        h = (h ^ word) * 0x100000001b3ULL;
+        h ^= h >> 29;
+    }
+    if (i < numSamples) {
+        juce::uint32 last;
+        std::memcpy(&last, samples + i, sizeof(last));
+        h = (h ^ last) * 0x100000001b3ULL;
+    }
+    return h ^ (h >> 32);
+}// end digest()
+
+bool ResultCache::lookup(juce::uint64 key, juce::uint64 indexVersion, std::pair<std::string, int>& result) {
+    std::lock_guard<std::mutex> guard(lock);
+    checkVersion(indexVersion);
+    if (!touch(key)) {
+        return false;
+    }
+    result = entries.front().second;
+    return true;
+}// end lookup()
+
+void ResultCache::store(juce::uint64 key, juce::uint64 indexVersion, const std::pair<std::string, int>& result) {
+    bool writeNow = false;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        checkVersion(indexVersion);
+        if (touch(key)) {
+            entries.front().second = result;
+        }
+        else {
+            entries.emplace_front(key, result);
+            results[key] = entries.begin();
+            if ((int)entries.size() > maxEntries) {
+                // drop the least recently used result
+                results.erase(entries.back().first);
+                entries.pop_back();
+            }
+        }
+        if (file != juce::File{}) {
+            pendingLines += formatEntry(entries.front());
+            numPending++;
+            writeNow = numPending >= appendBatch || rewriteFile;
+        }
+    }
+    // the disk is only touched once the lock is released, other workers keep looking results up
+    if (writeNow) {
+        writeFile(false);
+    }
+}// end store()
+
+void ResultCache::flush() {
+    writeFile(true);
+}// end flush()
+
+int ResultCache::size() {
+    std::lock_guard<std::mutex> guard(lock);
+    return (int)entries.size();
+}// end size()
+
+void ResultCache::checkVersion(juce::uint64 indexVersion) {
+    if (indexVersion == version) {
+        return;
+    }
+    // the index changed since these results were computed
+    entries.clear();
+    results.clear();
+    pendingLines.clear();
+    numPending = 0;
+    version = indexVersion;
+    rewriteFile = true;
+}// end checkVersion()
+
+bool ResultCache::touch(juce::uint64 key) {
+    auto found = results.find(key);
+    if (found == results.end()) {
+        return false;
+    }
+    entries.splice(entries.begin(), entries, found->second);
+    return true;
+}// end touch()
+
+void ResultCache::writeFile(bool wait) {
+    std::unique_lock<std::mutex> fileGuard(fileLock, std::defer_lock);
+    if (wait) {
+        fileGuard.lock();
+    }
+    else if (!fileGuard.try_lock()) {
+        return;  // another worker is writing, the batch is picked up by the next write
+    }
+    juce::File target;
+    std::string text;
+    bool replace = false;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (file == juce::File{} || (numPending == 0 && !rewriteFile)) {
+            return;  // nothing to write
+        }
+        target = file;
+        // evicted results leave stale lines behind, rewrite once they outnumber the live ones
+        replace = rewriteFile || fileLines + numPending > 2 * maxEntries;
+        if (replace) {
+            text = "version " + juce::String(version).toStdString() + "\n";
+            for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+                text += formatEntry(*it);  // oldest first, so the most recent results are read last
+            }
+            fileLines = (int)entries.size();
+        }
+        else {
+            text.swap(pendingLines);
+            fileLines += numPending;
+        }
+        pendingLines.clear();
+        numPending = 0;
+        rewriteFile = false;
+    }
+    if (replace) {
+        target.replaceWithText(juce::String(text), false, false, "\n");
+    }
+    else {
+        // append so saving results doesn't rewrite the whole file
+        juce::FileOutputStream outputStream(target);
+        if (outputStream.openedOk()) {
+            outputStream << juce::String(text);
+        }
+    }
+}// end writeFile()
+
+std::string ResultCache::formatEntry(const Entry& entry) {
+    return std::to_string(entry.first) + " " + std::to_string(entry.second.second) + " " + entry.second.first + "\n";
+}// end formatEntry()
@@ -0,0 +1,91 @@
+/*
+  ==============================================================================
+
+    ResultCache.h
+    Created: 19 Oct 2026 6:05:31pm
+    Author:  arago
+
+    Remembers the prediction made for a piece of decoded audio, so the same
+    upload checked again skips the FFT and matching. Results are keyed by a
+    digest of the samples and are only valid for the HashTable version they
+    were computed against, any change to the table empties the cache.
+
+    At most 'maxEntries' results are kept, the least recently used one is
+    dropped first. New results are appended to the file in batches of
+    'appendBatch' lines outside the lock (and on flush() or destruction), and
+    once the file holds twice as many lines as the cache it is rewritten with
+    just the cached results. Results not yet flushed are lost if the process
+    dies, which only costs a re-analysis.
+
+    File format:
+        version <HashTable version>
+        <digest> <votes> <song name>      one line per cached result, later lines are more recent
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class ResultCache {
+public:
+    enum
+    {
+        defaultMaxEntries = 100000,
+        appendBatch = 64 // results gathered before they are written to the file
+    };
+
+    explicit ResultCache(int maxEntries = defaultMaxEntries);
+    ~ResultCache();
+
+    // read results saved by an earlier run, new results are appended to the same file
+    void load(const juce::File& cacheFile);
+
+    // cheap digest of decoded mono samples, used as the cache key
+    static juce::uint64 digest(const float* samples, int numSamples, double sampleRate);
+
+    // true and fills 'result' with <song name, votes> if 'key' was cached against this index version
+    bool lookup(juce::uint64 key, juce::uint64 indexVersion, std::pair<std::string, int>& result);
+
+    // remember the result for 'key', dropping everything cached against another index version
+    void store(juce::uint64 key, juce::uint64 indexVersion, const std::pair<std::string, int>& result);
+
+    // write results that haven't reached the file yet
+    void flush();
+
+    // number of results held in memory
+    int size();
+
+private:
+    using Entry = std::pair<juce::uint64, std::pair<std::string, int>>; // <digest, <song name, votes>>
+
+    // empty the cache if it was filled against another index version, the file is rewritten on the next write
+    void checkVersion(juce::uint64 indexVersion);
+
+    // move 'key' to the front of the recency list, false if it isn't cached
+    bool touch(juce::uint64 key);
+
+    // append the batched results, or rewrite the file when it has to be emptied or compacted.
+    // 'wait' is false on the worker path, where another thread already writing is good enough
+    void writeFile(bool wait);
+
+    static std::string formatEntry(const Entry& entry);
+
+    const int maxEntries;
+    std::mutex lock; // the match server looks results up from several worker threads
+    std::mutex fileLock; // held while the file is written, so writes land in the order they were taken
+    juce::File file;
+    juce::uint64 version = 0;
+    std::list<Entry> entries; // most recently used first
+    std::unordered_map<juce::uint64, std::list<Entry>::iterator> results;
+    std::string pendingLines; // results not yet appended to the file
+    int numPending = 0;
+    int fileLines = 0; // result lines in the file, including ones for evicted results
+    bool rewriteFile = false; // the file holds another version's results or too many stale lines
+};
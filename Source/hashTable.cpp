@@ -9,17 +9,51 @@
 */
 
 #include "hashTable.h"
+#include <sstream>
+
+// first line of every database, timestamps are frame indices (older databases have none and count whole seconds)
+static const char* const formatLine = "format frames";
+
+// true if 'text' is one whole number, surrounding whitespace allowed
+template <typename Number>
+static bool parseNumber(const std::string& text, Number& value) {
+    std::istringstream ss(text);
+    return (ss >> value) && (ss >> std::ws).eof();
+}// end parseNumber()
+
+static juce::uint64 elementHash(long fp, int time, const std::string& name) {
+    // splitmix64 over the element, so summing them doesn't depend on insertion order
+    juce::uint64 h = (juce::uint64)fp * 0x9e3779b97f4a7c15ULL + (juce::uint64)(juce::uint32)time + std::hash<std::string>{}(name);
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    return h ^ (h >> 31);
+}// end elementHash()
 
 void HashTable::insertElement(long fp, int time, std::string name) {
+    version += elementHash(fp, time, name);
+    numFrames[name]++;
     // Insert data in the hash table:
-    table[fp].push_back(DataPoint(name, time));
+    auto& bucket = table[fp];
+    if (bucket.empty()) {
+        // first time seeing this fingerprint, add it to the filter
+        if (filter.size() >= filter.capacity()) {
+            rebuildFilter();
+        }
+        filter.insert(fp);
+    }
+    bucket.push_back(DataPoint(name, time));
 
 }// end insertElement()
 
-bool HashTable::check(long fingerprint, int time, std::vector<std::pair<std::string, int>> &matches) {
-    if (table[fingerprint].size()) {
+bool HashTable::check(long fingerprint, int time, std::vector<std::pair<std::string, int>> &matches) const {
+    // most query fingerprints miss, the filter rejects them without walking the map
+    if (!filter.mightContain(fingerprint)) {
+        return false;
+    }
+    auto found = table.find(fingerprint);
+    if (found != table.end() && found->second.size()) {
         // fingerprint exists
-        for (auto it = table[fingerprint].begin(); it != table[fingerprint].end(); it++) {
+        for (auto it = found->second.begin(); it != found->second.end(); it++) {
             // add all ofsets and song names too the potenital matches
             matches.push_back(std::make_pair(it->getSongId(), (it->getTime() - time)));
         }
@@ -28,7 +62,159 @@ bool HashTable::check(long fingerprint, int time, std::vector<std::pair<std::str
     return false;
 }// end check()
 
+int HashTable::getNumFrames(const std::string& name) const {
+    auto found = numFrames.find(name);
+    return found != numFrames.end() ? found->second : 0;
+}// end getNumFrames()
+
+juce::uint64 HashTable::getVersion() const {
+    // the same fingerprints made with another profile or at another rate mean something else
+    return version ^ std::hash<std::string>{}(profile) ^ (std::hash<double>{}(sampleRate) * 0x9e3779b97f4a7c15ULL);
+}// end getVersion()
+
+void HashTable::setProfile(const std::string& name) {
+    profile = name;
+}// end setProfile()
+
+std::string HashTable::getProfile() const {
+    return profile;
+}// end getProfile()
+
+void HashTable::setSampleRate(double rate) {
+    sampleRate = rate;
+}// end setSampleRate()
+
+double HashTable::getSampleRate() const {
+    return sampleRate;
+}// end getSampleRate()
+
+void HashTable::addAlias(const std::string& name, const std::string& canonical) {
+    aliases[name] = getCanonicalName(canonical);
+}// end addAlias()
+
+std::string HashTable::getCanonicalName(const std::string& name) const {
+    auto found = aliases.find(name);
+    return found != aliases.end() ? found->second : name;
+}// end getCanonicalName()
+
+bool HashTable::loadFromFile(const juce::File& fingerprintData) {
+    if (!fingerprintData.existsAsFile()) {
+        DBG(fingerprintData.getFileName() << " doesnt not exist");
+        return false;  // file doesn't exist
+    }
+    juce::FileInputStream inputStream(fingerprintData);
+    if (!inputStream.openedOk()) {
+        DBG("failed to open " << inputStream.getFile().getFileName());
+        return false;  // failed to open
+    }
+    if (inputStream.readNextLine().trim() != formatLine) {
+        DBG(fingerprintData.getFileName() << " has no '" << formatLine << "' line, it was made before frame timestamps and has to be rebuilt");
+        return false;  // whole second timestamps, every offset would be wrong
+    }
+    bool hasFingerprint = false;
+    bool hasProfile = false;
+    bool hasRate = false;
+    while (!inputStream.isExhausted()) {
+        std::istringstream ss(inputStream.readNextLine().toStdString());
+        std::string word;
+        long fp;
+        ss >> word;
+        if (word == "*") {
+            if (!hasProfile || !hasRate) {
+                DBG(fingerprintData.getFileName() << " doesn't say which profile and rate built it");
+                return false;  // can't analyse queries the same way
+            }
+            hasFingerprint = true;
+        }
+        else if (word == "profile") {
+            hasProfile = (bool)(ss >> profile);
+        }
+        else if (word == "rate") {
+            hasRate = (bool)(ss >> sampleRate) && sampleRate > 0;
+        }
+        else if (word == "alias") {
+            // "alias <name>/<canonical>", song names can hold spaces but never a '/'
+            std::string names;
+            ss.get();
+            std::getline(ss, names);
+            auto split = names.find('/');
+            if (split != std::string::npos) {
+                addAlias(names.substr(0, split), names.substr(split + 1));
+            }
+        }
+        else if (hasFingerprint) {
+            int num_prints = 0;
+            if (!parseNumber(word, fp) || !parseNumber(inputStream.readNextLine().toStdString(), num_prints) || num_prints < 0) {
+                DBG(fingerprintData.getFileName() << " has a bad fingerprint entry");
+                return false;  // not a database, or a damaged one
+            }
+            for (int i = 0; i < num_prints; i++) {
+                // "<name> <frame>", the frame is after the last space since the name can hold spaces
+                std::string line = inputStream.readNextLine().trim().toStdString();
+                auto split = line.rfind(' ');
+                int frame = 0;
+                if (split == std::string::npos || !parseNumber(line.substr(split + 1), frame)) {
+                    DBG(fingerprintData.getFileName() << " has a bad posting line: " << line);
+                    return false;
+                }
+                insertElement(fp, frame, line.substr(0, split));
+            }
+            hasFingerprint = false;
+        }
+    }
+    if (!hasProfile || !hasRate) {
+        DBG(fingerprintData.getFileName() << " doesn't say which profile and rate built it");
+        return false;
+    }
+    return true;
+}// end loadFromFile()
+
+bool HashTable::saveToFile(const juce::File& fingerprintData) const {
+    // write next to the database first, so a failed write leaves the old one alone
+    juce::TemporaryFile temporaryFile(fingerprintData);
+    {
+        juce::FileOutputStream outputStream(temporaryFile.getFile());
+        if (!outputStream.openedOk()) {
+            DBG("failed to open " << temporaryFile.getFile().getFileName());
+            return false;  // failed to open
+        }
+        outputStream << formatLine << "\n";
+        outputStream << "profile " << juce::String(profile) << "\n";
+        outputStream << "rate " << juce::String(sampleRate) << "\n";
+        for (auto const& [name, canonical] : aliases) {
+            outputStream << "alias " << juce::String(name) << "/" << juce::String(canonical) << "\n";
+        }
+        for (auto const& [key, val] : table) {
+            outputStream << "*\n" << juce::String((juce::int64)key) << "\n" << (int)val.size() << "\n";
+            for (auto const& dp : val) {
+                outputStream << juce::String(dp.getSongId()) << " " << dp.getTime() << "\n";
+            }
+        }
+        outputStream.flush();
+        if (outputStream.getStatus().failed()) {
+            DBG("failed to write " << temporaryFile.getFile().getFileName());
+            return false;
+        }
+    }
+    return temporaryFile.overwriteTargetFileWithTemporary();
+}// end saveToFile()
+
+void HashTable::rebuildFilter() {
+    filter.reset(filter.capacity() * 2);
+    for (auto const& [key, val] : table) {
+        if (val.size()) {
+            filter.insert(key);
+        }
+    }
+}// end rebuildFilter()
+
 void HashTable::printAll() {
+    DBG(formatLine);
+    DBG("profile " << profile);
+    DBG("rate " << sampleRate);
+    for (auto const& [name, canonical] : aliases) {
+        DBG("alias " << name << "/" << canonical);
+    }
     DBG("NUMBER OF FINGER PRINTS: " << table.size());
     for (auto const& [key, val] : table) {
         DBG("*\n" << key);
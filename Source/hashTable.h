@@ -14,6 +14,8 @@
 #pragma once
 #include <JuceHeader.h>
 #include "DataPoint.h"
+#include "BloomFilter.h"
+#include "AnalysisProfiles.h"
 #include <iostream>
 #include <list>
 #include <map>
@@ -29,12 +31,47 @@ public:
     // Insert data in the hash table:
     void insertElement(long fp, int time, std::string name);
 
-    // check for potential matches
-    bool check(long fingerprint, int time, std::vector<std::pair<std::string, int>> &matches);
+    // check for potential matches, safe to call from several threads once the table is built
+    bool check(long fingerprint, int time, std::vector<std::pair<std::string, int>> &matches) const;
+
+    // read fingerprints written out by saveToFile() or printAll(), returns false if the file couldn't be read
+    // or wasn't written with frame index timestamps (databases from before then count whole seconds and must be rebuilt)
+    bool loadFromFile(const juce::File& fingerprintData);
+
+    // write the profile, rate, aliases and fingerprints in the format loadFromFile() reads, returns false if the file couldn't be written
+    bool saveToFile(const juce::File& fingerprintData) const;
+
+    // number of fingerprints inserted for 'name', one per frame of the song
+    int getNumFrames(const std::string& name) const;
+
+    // changes whenever an element is inserted, two tables holding the same elements have the same version
+    juce::uint64 getVersion() const;
+
+    // name of the analysis profile the fingerprints were made with (see AnalysisProfiles.h)
+    void setProfile(const std::string& name);
+    std::string getProfile() const;
+
+    // sample rate the fingerprinted audio was analysed at, frame indices are only comparable at the same rate
+    void setSampleRate(double rate);
+    double getSampleRate() const;
+
+    // record 'name' as a near-duplicate of 'canonical', which holds the postings for both
+    void addAlias(const std::string& name, const std::string& canonical);
+    // the name holding the postings for 'name', 'name' itself if it isn't an alias
+    std::string getCanonicalName(const std::string& name) const;
 
     // print all values in map
     void printAll();
 
 private:
+    // grow the filter and re-add every key once it holds more keys than it was sized for
+    void rebuildFilter();
+
     std::map<long, std::vector<DataPoint>> table;
+    BloomFilter filter; // rejects most missing fingerprints before the map is searched
+    juce::uint64 version = 0;
+    std::string profile = DefaultProfile::name; // for tables built in memory, a loaded database always names its profile
+    double sampleRate = 44100.0; // for tables built in memory, a loaded database always names its rate
+    std::map<std::string, std::string> aliases; // <duplicate song name, canonical song name>
+    std::map<std::string, int> numFrames; // <song name, fingerprints inserted for it>
 };